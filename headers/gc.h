@@ -2,6 +2,8 @@
 
 #include "gc_obj.h"
 #include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
 
 /// @brief The alias of the gc context
 typedef struct gc gc_t;
@@ -42,3 +44,41 @@ int gc_push(gc_t *gc, void *blc, size_t blcSize, gc_destrutor objDestr);
 /// @param gc The garbage collector context
 /// @pre gc cannot be NULL
 void gc_collect(gc_t *gc);
+
+/// @brief Set the memory limit that forces a collection when the usage is getting close to it
+/// @note When the managed heap reaches GC_PRESSURE_THRESHOLD percent of the limit, a collection is forced
+///       and the freed memory is given back to the operating system.
+///       Without a configured limit, the cgroup v2 limit is used when available.
+/// @param gc The garbage collector context
+/// @param limit The memory limit in bytes, 0 to remove the configured limit
+/// @pre gc cannot be NULL
+void gc_set_memory_limit(gc_t *gc, size_t limit);
+
+/// @brief Start the sampling allocation profiler
+/// @note The blocks given to gc_alloc and gc_push are sampled on average once every sampleRate bytes,
+///       and the backtrace of the call site is recorded. A running profiler is restarted with no samples.
+/// @param gc The garbage collector context
+/// @param sampleRate The mean number of bytes between two samples, 0 to use GC_PROFILER_SAMPLE_RATE
+/// @pre gc cannot be NULL
+/// @return 0 if the operation success, -1 otherwise
+int gc_start_profiling(gc_t *gc, size_t sampleRate);
+
+/// @brief Stop the sampling allocation profiler and drop its samples
+/// @param gc The garbage collector context
+/// @pre gc cannot be NULL
+void gc_stop_profiling(gc_t *gc);
+
+/// @brief Write the allocation profile as folded stacks, as used by flamegraph.pl
+/// @note Exported functions are written by name. The other frames are written as "binary+offset",
+///       with the offset from the load address of the binary, to symbolize with addr2line.
+///       Link with -rdynamic to get the name of the functions of the executable.
+/// @param gc The garbage collector context
+/// @param file The file where the profile is written
+/// @param onlyLive If true, only write the samples that are still alive, with the number of collections they survived.
+///                 Otherwise, also write the samples of the collected blocks. Those are kept in a reservoir of
+///                 GC_PROFILER_MAX_FREED_SAMPLES samples, reweighted to stand for every collected sample, so the
+///                 profile doesn't have one line per sample once the reservoir is full.
+/// @pre gc cannot be NULL
+/// @pre file cannot be NULL
+/// @return 0 if the operation success, -1 if the profiler is not started or on failure
+int gc_write_profile(gc_t *gc, FILE *file, bool onlyLive);
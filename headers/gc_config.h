@@ -10,3 +10,13 @@
 #define GC_PADDING_SIZE (sizeof(struct{ int A; char B; }) - sizeof(int))
 #define GC_MAX_OBJ_INIT 6
 #define GC_UNDERFINED_SIZE 0
+#define GC_NO_MEMORY_LIMIT 0
+#define GC_PRESSURE_THRESHOLD 90 // percentage of the memory limit that trigger a collection
+#define GC_PRESSURE_MIN_CHECK_INTERVAL (4 * 1024 * 1024) // minimum bytes allocated between two reads of the cgroup usage
+#define GC_PRESSURE_UNSIZED_ALLOC 64 // bytes counted for a block pushed without a size
+#define GC_CGROUP_ROOT "/sys/fs/cgroup"
+#define GC_PROC_SELF_CGROUP "/proc/self/cgroup"
+#define GC_PROFILER_SAMPLE_RATE (512 * 1024) // mean bytes allocated between two samples
+#define GC_PROFILER_MAX_DEPTH 32
+#define GC_PROFILER_SKIPPED_FRAMES 2 // gc_profiler_record and gc_alloc/gc_push
+#define GC_PROFILER_MAX_FREED_SAMPLES 4096
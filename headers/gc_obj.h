@@ -16,5 +16,6 @@ struct gc_obj {
 
 	gc_obj_t *next;
 	bool marked;
+	bool sampled;
 };
 
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef struct gc_pressure gc_pressure_t;
+
+/// @brief Create a memory pressure monitor
+/// @note If a cgroup v2 memory limit is available, it is used until a limit is configured.
+///       The cgroup is the one of /proc/self/cgroup, or its nearest ancestor that has a limit.
+/// @return A new memory pressure monitor if the allocation success, NULL otherwise
+gc_pressure_t* gc_pressure_create(void);
+
+/// @brief Destroy a memory pressure monitor
+/// @param pressure The memory pressure monitor
+/// @pre pressure cannot be NULL
+void gc_pressure_release(gc_pressure_t *pressure);
+
+/// @brief Configure the memory limit
+/// @note A configured limit is compared to the size of the managed heap, which lets you simulate a limit
+///       without a cgroup. GC_NO_MEMORY_LIMIT goes back to the cgroup limit, if there is one.
+/// @param pressure The memory pressure monitor
+/// @param limit The memory limit in bytes
+/// @pre pressure cannot be NULL
+void gc_pressure_set_limit(gc_pressure_t *pressure, size_t limit);
+
+/// @brief Let you know if the memory usage is close to the limit
+/// @note A configured limit is checked on each allocation. The cgroup usage is only read again once half of
+///       its distance to the next trigger has been allocated, with at least GC_PRESSURE_MIN_CHECK_INTERVAL bytes.
+///       A block without size is counted as GC_PRESSURE_UNSIZED_ALLOC bytes.
+/// @param pressure The memory pressure monitor
+/// @param heapSize The size of the managed heap
+/// @param allocSize The size of the block that is going to be allocated
+/// @pre pressure cannot be NULL
+/// @return true if a collection should be forced, false otherwise
+bool gc_pressure_high(gc_pressure_t *pressure, size_t heapSize, size_t allocSize);
+
+/// @brief Indicate that a collection has been forced by the memory pressure
+/// @note The usage after the collection is recorded, and another collection is only forced once the usage
+///       has grown past it, so a heap that stays above the threshold doesn't collect on each check
+/// @param pressure The memory pressure monitor
+/// @param heapSize The size of the managed heap after the collection
+/// @pre pressure cannot be NULL
+void gc_pressure_collected(gc_pressure_t *pressure, size_t heapSize);
+
+/// @brief Give the freed memory back to the operating system
+/// @note Does nothing if the allocator cannot be trimmed
+void gc_pressure_trim(void);
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+typedef struct gc_profiler gc_profiler_t;
+
+/// @brief Create a sampling allocation profiler
+/// @note Allocations are sampled on average once every sampleRate bytes, with a Poisson process
+/// @param sampleRate The mean number of bytes between two samples
+/// @pre sampleRate cannot be equal to 0
+/// @return A new profiler if the allocation success, NULL otherwise
+gc_profiler_t* gc_profiler_create(size_t sampleRate);
+
+/// @brief Destroy a sampling allocation profiler
+/// @param profiler The profiler
+/// @pre profiler cannot be NULL
+void gc_profiler_release(gc_profiler_t *profiler);
+
+/// @brief Count an allocation and record its backtrace if it is sampled
+/// @param profiler The profiler
+/// @param data The allocated block of memory
+/// @param size The size of the block
+/// @pre profiler cannot be NULL
+/// @pre data cannot be NULL
+/// @return true if the allocation was sampled, false otherwise
+bool gc_profiler_record(gc_profiler_t *profiler, void *data, size_t size);
+
+/// @brief Indicate that a sampled block of memory has been collected
+/// @param profiler The profiler
+/// @param data The collected block of memory
+/// @pre profiler cannot be NULL
+void gc_profiler_free(gc_profiler_t *profiler, void *data);
+
+/// @brief Indicate that the live samples have survived a collection
+/// @param profiler The profiler
+/// @pre profiler cannot be NULL
+void gc_profiler_collect(gc_profiler_t *profiler);
+
+/// @brief Write the samples as folded stacks, one "frame;frame;frame bytes" line per sample
+/// @note The bytes are an estimation of the memory allocated by the call site, not the size of the sample
+/// @param profiler The profiler
+/// @param file The file where the profile is written
+/// @param onlyLive If true, only write the samples that are not collected, with the number of collections they survived
+/// @pre profiler cannot be NULL
+/// @pre file cannot be NULL
+/// @return 0 if the operation success, -1 otherwise
+int gc_profiler_write(gc_profiler_t *profiler, FILE *file, bool onlyLive);
@@ -1,7 +1,9 @@
 #include "gc.h"
 
 #include <stdlib.h>
+#include <string.h>
 #include <stdio.h>
+#include <stdbool.h>
 
 struct A {
 	struct B* b;
@@ -24,9 +26,142 @@ void f(gc_t *gc) {
 	b->a = a;
 }
 
+size_t nbCollected = 0;
+
+void countCollected(void *data) {
+	++nbCollected;
+	free(data);
+}
+
+void allocUnreferenced(gc_t *gc, size_t size) {
+	gc_alloc(gc, size, countCollected);
+}
+
+// with a simulated limit of 10000 bytes, the pressure threshold (90%) is at 9000 bytes
+bool checkPressure(int *argc, char *argv[]) {
+	gc_t *gc = gc_create(argc, argv);
+	if (!gc)
+		return false;
+	gc_set_memory_limit(gc, 10000);
+
+	// 8500 bytes stay alive, in 5 blocks so the object count doesn't trigger a collection
+	void *live[5];
+	for (size_t i = 0; i < sizeof live / sizeof *live; ++i)
+		live[i] = gc_alloc(gc, 1700, countCollected);
+
+	bool ok = true;
+	// 8500 + 400 stays below the threshold
+	allocUnreferenced(gc, 400);
+	ok = ok && nbCollected == 0;
+	// 8900 + 200 crosses it, the 400 bytes block is collected
+	allocUnreferenced(gc, 200);
+	ok = ok && nbCollected == 1;
+	// the live data stays above the threshold, the next forced collection waits for 8500 + 750 bytes
+	allocUnreferenced(gc, 400);
+	ok = ok && nbCollected == 1;
+	allocUnreferenced(gc, 200);
+	ok = ok && nbCollected > 1;
+
+	ok = ok && live[0] != NULL;
+	gc_release(gc);
+	nbCollected = 0;
+	return ok;
+}
+
+// with a sample rate of 1 byte every allocation is sampled, and the profile must give back their sizes
+bool checkProfile(gc_t *gc) {
+	size_t const sizes[] = { 24, 40, 72, 56 };
+	size_t const nbSizes = sizeof sizes / sizeof *sizes;
+	bool found[sizeof sizes / sizeof *sizes] = { false };
+
+	FILE *file = tmpfile();
+	if (!file)
+		return false;
+	if (gc_start_profiling(gc, 1) == -1) {
+		fclose(file);
+		return false;
+	}
+	for (size_t i = 0; i < nbSizes - 1; ++i)
+		gc_alloc(gc, sizes[i], NULL);
+	gc_push(gc, malloc(sizes[nbSizes - 1]), sizes[nbSizes - 1], NULL);
+	gc_write_profile(gc, file, false);
+	gc_stop_profiling(gc);
+
+	rewind(file);
+	char line[4096];
+	size_t nbLines = 0;
+	bool ok = true;
+	while (fgets(line, sizeof line, file)) {
+		size_t weight = strtoul(strrchr(line, ' ') + 1, NULL, 10);
+		size_t i = 0;
+		while (i < nbSizes && (found[i] || sizes[i] != weight))
+			++i;
+		if (i == nbSizes)
+			ok = false;
+		else
+			found[i] = true;
+		++nbLines;
+	}
+	fclose(file);
+	return ok && nbLines == nbSizes;
+}
+
+// the blocks stay referenced from this frame, so their samples must be live and survive both collections
+bool checkLiveProfile(int *argc, char *argv[]) {
+	gc_t *gc = gc_create(argc, argv);
+	if (!gc)
+		return false;
+	FILE *file = tmpfile();
+	if (!file || gc_start_profiling(gc, 1) == -1) {
+		if (file)
+			fclose(file);
+		gc_release(gc);
+		return false;
+	}
+
+	void *live[3];
+	size_t const nbLive = sizeof live / sizeof *live;
+	for (size_t i = 0; i < nbLive; ++i)
+		live[i] = gc_alloc(gc, 32, NULL);
+	gc_collect(gc);
+	gc_collect(gc);
+	gc_write_profile(gc, file, true);
+
+	rewind(file);
+	char line[4096];
+	size_t nbLines = 0;
+	bool ok = true;
+	while (fgets(line, sizeof line, file)) {
+		if (!strstr(line, ";[survived 2 collections] "))
+			ok = false;
+		++nbLines;
+	}
+	fclose(file);
+
+	ok = ok && nbLines == nbLive && live[0] != NULL;
+	gc_release(gc);
+	return ok;
+}
+
 int main(int argc, char *argv[]) {
+	if (!checkPressure(&argc, argv)) {
+		puts("wrong memory pressure collections");
+		return EXIT_FAILURE;
+	}
+
 	gc_t *gc = gc_create(&argc, argv);
 
+	if (!checkProfile(gc)) {
+		puts("wrong allocation profile");
+		gc_release(gc);
+		return EXIT_FAILURE;
+	}
+	if (!checkLiveProfile(&argc, argv)) {
+		puts("wrong live allocation profile");
+		gc_release(gc);
+		return EXIT_FAILURE;
+	}
+
 	f(gc);
 
 	gc_release(gc);
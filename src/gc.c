@@ -2,6 +2,8 @@
 #include "gc_config.h"
 #include "gc_obj.h"
 #include "gc_dyn_array.h"
+#include "gc_pressure.h"
+#include "gc_profiler.h"
 
 #include <stdint.h>
 #include <stdlib.h>
@@ -11,9 +13,12 @@ typedef uint8_t octet;
 struct gc {
 	size_t nbObjs;
 	size_t maxObjs;
+	size_t heapSize;
 
 	octet *stackBase;
 	gc_obj_t *first;
+	gc_pressure_t *pressure;
+	gc_profiler_t *profiler;
 };
 
 // private
@@ -116,7 +121,10 @@ static void sweep(gc_t *gc) {
 		if (!(*objects)->marked) {
 			gc_obj_t *toFree = *objects;
 			*objects = toFree->next;
+			if (toFree->sampled && gc->profiler)
+				gc_profiler_free(gc->profiler, toFree->data);
 			toFree->destr(toFree->data);
+			gc->heapSize -= toFree->size;
 			free(toFree);
 
 			--gc->nbObjs;
@@ -128,6 +136,18 @@ static void sweep(gc_t *gc) {
 	}
 }
 
+static void collectIfNeeded(gc_t *gc, size_t allocSize) {
+	assert(gc != NULL && "gc context must exist");
+
+	if (gc_pressure_high(gc->pressure, gc->heapSize, allocSize)) {
+		gc_collect(gc);
+		gc_pressure_trim();
+		gc_pressure_collected(gc->pressure, gc->heapSize);
+	}
+	else if (gc->nbObjs >= gc->maxObjs)
+		gc_collect(gc);
+}
+
 // interface
 
 gc_t* gc_create(int * argc, char * argv[]) {
@@ -138,16 +158,23 @@ gc_t* gc_create(int * argc, char * argv[]) {
 
 	gc_t *gc = malloc(sizeof *gc);
 	if (gc) {
-		*gc = (gc_t) { 0, GC_MAX_OBJ_INIT, NULL, NULL };
+		*gc = (gc_t) { 0, GC_MAX_OBJ_INIT, 0, NULL, NULL, NULL, NULL };
+		gc->pressure = gc_pressure_create();
+		if (!gc->pressure)
+			goto cleanup;
 		gc->stackBase = (octet*)argc;
 		return gc;
 	}
+cleanup:
+	free(gc);
 	return NULL;
 }
 
 void gc_release(gc_t * gc) {
 	assert(gc != NULL && "Invalid argument: this pointer can't be NULL");
 	gc_collect(gc);
+	gc_stop_profiling(gc);
+	gc_pressure_release(gc->pressure);
 	free(gc);
 }
 
@@ -155,8 +182,7 @@ void* gc_alloc(gc_t * gc, size_t size, gc_destrutor objDestr) {
 	assert(gc != NULL && "gc context must be a valid pointer to object");
 	assert(size != 0 && "Object size cannot be equal to 0");
 
-	if (gc->nbObjs >= gc->maxObjs)
-		gc_collect(gc);
+	collectIfNeeded(gc, size);
 
 	gc_obj_t *obj = malloc(sizeof *obj);
 	if (obj) {
@@ -166,9 +192,11 @@ void* gc_alloc(gc_t * gc, size_t size, gc_destrutor objDestr) {
 		obj->destr = (objDestr) ? objDestr : free;
 		obj->marked = false;
 		obj->size = size;
+		obj->sampled = gc->profiler && gc_profiler_record(gc->profiler, obj->data, obj->size);
 
 		addToObjList(gc, obj);
 		++gc->nbObjs;
+		gc->heapSize += obj->size;
 
 		return obj->data;
 	}
@@ -182,8 +210,7 @@ int gc_push(gc_t * gc, void * blc, size_t blcSize, gc_destrutor objDestr) {
 	assert(blc != NULL && "The block of memory cannot be NULL");
 	assert(!isInList(gc, blc) && "The object is already in the gc list");
 
-	if (gc->nbObjs >= gc->maxObjs)
-		gc_collect(gc);
+	collectIfNeeded(gc, blcSize);
 
 	gc_obj_t *obj = malloc(sizeof *obj);
 	if (obj) {
@@ -191,9 +218,11 @@ int gc_push(gc_t * gc, void * blc, size_t blcSize, gc_destrutor objDestr) {
 		obj->destr = (objDestr) ? objDestr : free;
 		obj->marked = false;
 		obj->size = blcSize;
+		obj->sampled = gc->profiler && gc_profiler_record(gc->profiler, obj->data, obj->size);
 
 		addToObjList(gc, obj);
 		++gc->nbObjs;
+		gc->heapSize += obj->size;
 
 		return 0;
 	}
@@ -205,6 +234,43 @@ void gc_collect(gc_t * gc) {
 
 	markAll(gc);
 	sweep(gc);
+	if (gc->profiler)
+		gc_profiler_collect(gc->profiler);
 
 	gc->maxObjs = gc->nbObjs * 2;
 }
+
+void gc_set_memory_limit(gc_t * gc, size_t limit) {
+	assert(gc != NULL && "gc context must be a valid pointer");
+
+	gc_pressure_set_limit(gc->pressure, limit);
+}
+
+int gc_start_profiling(gc_t * gc, size_t sampleRate) {
+	assert(gc != NULL && "gc context must be a valid pointer");
+
+	gc_profiler_t *profiler = gc_profiler_create(sampleRate ? sampleRate : GC_PROFILER_SAMPLE_RATE);
+	if (!profiler)
+		return -1;
+	gc_stop_profiling(gc);
+	gc->profiler = profiler;
+	return 0;
+}
+
+void gc_stop_profiling(gc_t * gc) {
+	assert(gc != NULL && "gc context must be a valid pointer");
+
+	if (!gc->profiler)
+		return;
+	gc_profiler_release(gc->profiler);
+	gc->profiler = NULL;
+}
+
+int gc_write_profile(gc_t * gc, FILE * file, bool onlyLive) {
+	assert(gc != NULL && "gc context must be a valid pointer");
+	assert(file != NULL && "The file must exist");
+
+	if (!gc->profiler)
+		return -1;
+	return gc_profiler_write(gc->profiler, file, onlyLive);
+}
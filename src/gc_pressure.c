@@ -0,0 +1,230 @@
+#include "gc_pressure.h"
+#include "gc_config.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#ifdef __GLIBC__
+#	include <malloc.h>
+#endif
+
+struct gc_pressure {
+	size_t limit;
+	size_t cgroupLimit;
+	char cgroupDir[FILENAME_MAX];
+
+	size_t allocSinceCheck;
+	size_t checkInterval;
+	size_t nextTrigger;
+};
+
+// private
+
+static int readSizeFrom(char const *path, size_t *value) {
+	assert(path != NULL && "The path must exist");
+	assert(value != NULL && "The value must exist");
+
+	FILE *file = fopen(path, "r");
+	if (!file)
+		return -1;
+
+	// memory.max contains "max" when the cgroup has no limit
+	unsigned long long readValue;
+	int error = (fscanf(file, "%llu", &readValue) == 1) ? 0 : -1;
+	fclose(file);
+
+	if (!error)
+		*value = (size_t)readValue;
+	return error;
+}
+
+static int readStatFrom(char const *path, char const *key, size_t *value) {
+	assert(path != NULL && "The path must exist");
+	assert(key != NULL && "The key must exist");
+	assert(value != NULL && "The value must exist");
+
+	FILE *file = fopen(path, "r");
+	if (!file)
+		return -1;
+
+	// memory.stat is made of "key value" lines
+	char readKey[64];
+	unsigned long long readValue;
+	int error = -1;
+	while (error && fscanf(file, "%63s %llu", readKey, &readValue) == 2) {
+		if (strcmp(readKey, key) == 0)
+			error = 0;
+	}
+	fclose(file);
+
+	if (!error)
+		*value = (size_t)readValue;
+	return error;
+}
+
+static int readCgroupFile(gc_pressure_t const *pressure, char const *name, size_t *value, char const *statKey) {
+	assert(pressure != NULL && "The memory pressure monitor must exist");
+	assert(name != NULL && "The file name must exist");
+
+	char path[FILENAME_MAX];
+	if (snprintf(path, sizeof path, "%s/%s", pressure->cgroupDir, name) >= (int)sizeof path)
+		return -1;
+	return statKey ? readStatFrom(path, statKey, value) : readSizeFrom(path, value);
+}
+
+static int findCgroupLimit(gc_pressure_t *pressure) {
+	assert(pressure != NULL && "The memory pressure monitor must exist");
+
+	FILE *file = fopen(GC_PROC_SELF_CGROUP, "r");
+	if (!file)
+		return -1;
+
+	// the cgroup v2 hierarchy is the "0::/path" line
+	char line[FILENAME_MAX];
+	int error = -1;
+	while (error && fgets(line, sizeof line, file)) {
+		if (strncmp(line, "0::", 3) == 0)
+			error = 0;
+	}
+	fclose(file);
+	if (error)
+		return -1;
+
+	line[strcspn(line, "\n")] = '\0';
+	if (snprintf(pressure->cgroupDir, sizeof pressure->cgroupDir, "%s%s", GC_CGROUP_ROOT, line + 3) >= (int)sizeof pressure->cgroupDir)
+		return -1;
+
+	// the limit can be set by any ancestor, use the nearest one
+	size_t rootLength = strlen(GC_CGROUP_ROOT);
+	for (size_t length = strlen(pressure->cgroupDir); length > rootLength && pressure->cgroupDir[length - 1] == '/'; --length)
+		pressure->cgroupDir[length - 1] = '\0';
+	while (readCgroupFile(pressure, "memory.max", &pressure->cgroupLimit, NULL) == -1) {
+		if (strlen(pressure->cgroupDir) <= rootLength)
+			return -1;
+		*strrchr(pressure->cgroupDir, '/') = '\0';
+	}
+	return 0;
+}
+
+static size_t thresholdOf(size_t limit) {
+	return limit / 100 * GC_PRESSURE_THRESHOLD + limit % 100 * GC_PRESSURE_THRESHOLD / 100;
+}
+
+static size_t limitOf(gc_pressure_t const *pressure) {
+	assert(pressure != NULL && "The memory pressure monitor must exist");
+
+	return (pressure->limit != GC_NO_MEMORY_LIMIT) ? pressure->limit : pressure->cgroupLimit;
+}
+
+static int readUsage(gc_pressure_t const *pressure, size_t heapSize, size_t *usage) {
+	assert(pressure != NULL && "The memory pressure monitor must exist");
+	assert(usage != NULL && "The usage must exist");
+
+	if (pressure->limit != GC_NO_MEMORY_LIMIT) {
+		*usage = heapSize;
+		return 0;
+	}
+	if (readCgroupFile(pressure, "memory.current", usage, NULL) == -1)
+		return -1;
+	if (*usage < thresholdOf(pressure->cgroupLimit))
+		return 0;
+
+	// the inactive page cache is reclaimed by the kernel before any OOM kill, don't count it
+	size_t inactiveFile;
+	if (readCgroupFile(pressure, "memory.stat", &inactiveFile, "inactive_file") == 0)
+		*usage = (*usage > inactiveFile) ? *usage - inactiveFile : 0;
+	return 0;
+}
+
+static size_t nextCheckInterval(gc_pressure_t const *pressure, size_t usage, size_t threshold) {
+	assert(pressure != NULL && "The memory pressure monitor must exist");
+
+	// the usage can't reach the trigger before half of the gap is allocated, read it again then
+	size_t trigger = (pressure->nextTrigger > threshold) ? pressure->nextTrigger : threshold;
+	size_t interval = (usage < trigger) ? (trigger - usage) / 2 : 0;
+	return (interval > GC_PRESSURE_MIN_CHECK_INTERVAL) ? interval : GC_PRESSURE_MIN_CHECK_INTERVAL;
+}
+
+// interface
+
+gc_pressure_t* gc_pressure_create(void) {
+	gc_pressure_t *pressure = malloc(sizeof *pressure);
+	if (pressure) {
+		*pressure = (gc_pressure_t) { GC_NO_MEMORY_LIMIT, GC_NO_MEMORY_LIMIT, "", 0, GC_PRESSURE_MIN_CHECK_INTERVAL, 0 };
+		if (findCgroupLimit(pressure) == -1)
+			pressure->cgroupLimit = GC_NO_MEMORY_LIMIT;
+		return pressure;
+	}
+	return NULL;
+}
+
+void gc_pressure_release(gc_pressure_t *pressure) {
+	assert(pressure != NULL && "The memory pressure monitor must exist");
+
+	free(pressure);
+}
+
+void gc_pressure_set_limit(gc_pressure_t *pressure, size_t limit) {
+	assert(pressure != NULL && "The memory pressure monitor must exist");
+
+	pressure->limit = limit;
+	pressure->allocSinceCheck = 0;
+	pressure->checkInterval = GC_PRESSURE_MIN_CHECK_INTERVAL;
+	pressure->nextTrigger = 0;
+}
+
+bool gc_pressure_high(gc_pressure_t *pressure, size_t heapSize, size_t allocSize) {
+	assert(pressure != NULL && "The memory pressure monitor must exist");
+
+	size_t limit = limitOf(pressure);
+	if (limit == GC_NO_MEMORY_LIMIT)
+		return false;
+
+	// a configured limit is cheap to check, but don't read the cgroup files on each allocation
+	if (pressure->limit == GC_NO_MEMORY_LIMIT) {
+		// a block pushed without a size still uses memory, count it so the usage is read again
+		pressure->allocSinceCheck += (allocSize != GC_UNDERFINED_SIZE) ? allocSize : GC_PRESSURE_UNSIZED_ALLOC;
+		if (pressure->allocSinceCheck < pressure->checkInterval)
+			return false;
+		pressure->allocSinceCheck = 0;
+	}
+
+	size_t usage;
+	if (readUsage(pressure, heapSize, &usage) == -1)
+		return false;
+	usage += allocSize;
+
+	size_t threshold = thresholdOf(limit);
+	if (usage < threshold)
+		pressure->nextTrigger = 0;
+	if (pressure->limit == GC_NO_MEMORY_LIMIT)
+		pressure->checkInterval = nextCheckInterval(pressure, usage, threshold);
+	return usage >= threshold && usage >= pressure->nextTrigger;
+}
+
+void gc_pressure_collected(gc_pressure_t *pressure, size_t heapSize) {
+	assert(pressure != NULL && "The memory pressure monitor must exist");
+
+	size_t limit = limitOf(pressure);
+	size_t usage;
+	if (limit == GC_NO_MEMORY_LIMIT || readUsage(pressure, heapSize, &usage) == -1)
+		return;
+
+	// wait for the usage to eat half of the remaining headroom, or half of the band above the threshold
+	// when there is no headroom left, before forcing another collection
+	size_t headroom = (usage < limit) ? limit - usage : 0;
+	size_t minGrowth = (limit - thresholdOf(limit)) / 2;
+	pressure->nextTrigger = usage + ((headroom / 2 > minGrowth) ? headroom / 2 : minGrowth);
+	if (pressure->limit == GC_NO_MEMORY_LIMIT) {
+		pressure->allocSinceCheck = 0;
+		pressure->checkInterval = nextCheckInterval(pressure, usage, thresholdOf(limit));
+	}
+}
+
+void gc_pressure_trim(void) {
+#ifdef __GLIBC__
+	malloc_trim(0);
+#endif
+}
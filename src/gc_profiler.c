@@ -0,0 +1,235 @@
+#define _GNU_SOURCE // dladdr
+
+#include "gc_profiler.h"
+#include "gc_config.h"
+#include "gc_dyn_array.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <assert.h>
+
+#if defined(__GLIBC__) || defined(__APPLE__)
+#	include <execinfo.h>
+#	include <dlfcn.h>
+#	define GC_PROFILER_HAS_BACKTRACE
+#endif
+
+typedef struct gc_sample gc_sample_t;
+struct gc_sample {
+	void *data;
+	size_t size;
+	size_t survived;
+
+	int depth;
+	void *frames[GC_PROFILER_MAX_DEPTH];
+};
+
+struct gc_profiler {
+	size_t sampleRate;
+	size_t bytesUntilSample;
+	uint64_t rngState;
+
+	gc_dyn_array_t *liveSamples;
+	gc_dyn_array_t *freedSamples;
+	size_t nbFreed;
+};
+
+// private
+
+static uint64_t nextRandom(gc_profiler_t *profiler) {
+	// xorshift64, the state is never equal to 0
+	profiler->rngState ^= profiler->rngState << 13;
+	profiler->rngState ^= profiler->rngState >> 7;
+	profiler->rngState ^= profiler->rngState << 17;
+	return profiler->rngState;
+}
+
+static size_t nextSampleDistance(gc_profiler_t *profiler) {
+	assert(profiler != NULL && "The profiler must exist");
+
+	// exponential distribution, so the samples follow a Poisson process over the allocated bytes
+	double uniform = ((nextRandom(profiler) >> 11) + 1) * (1.0 / 9007199254740992.0); // in ]0, 1]
+	return (size_t)(-log(uniform) * (double)profiler->sampleRate) + 1;
+}
+
+static double estimatedBytes(gc_profiler_t const *profiler, gc_sample_t const *sample) {
+	assert(profiler != NULL && "The profiler must exist");
+	assert(sample != NULL && "The sample must exist");
+
+	// a block of memory of this size had 1 - e^(-size / rate) chance to be sampled
+	double size = (double)sample->size;
+	return size / (1.0 - exp(-size / (double)profiler->sampleRate));
+}
+
+static void writeFrame(FILE *file, void *address) {
+	assert(file != NULL && "The file must exist");
+
+#ifdef GC_PROFILER_HAS_BACKTRACE
+	Dl_info info;
+	if (dladdr(address, &info) && info.dli_sname) {
+		fputs(info.dli_sname, file);
+		return;
+	}
+	// the function is not exported (no -rdynamic, static function), write "binary+offset" so it can be
+	// symbolized with addr2line. The address is a return address, step back into the call instruction.
+	if (dladdr(address, &info) && info.dli_fname) {
+		char const *name = strrchr(info.dli_fname, '/');
+		fprintf(file, "%s+0x%tx", name ? name + 1 : info.dli_fname, (char*)address - 1 - (char*)info.dli_fbase);
+		return;
+	}
+#endif
+	fprintf(file, "%p", address);
+}
+
+static int keepFreedSample(gc_profiler_t *profiler, gc_sample_t const *sample) {
+	assert(profiler != NULL && "The profiler must exist");
+	assert(sample != NULL && "The sample must exist");
+
+	// reservoir sampling, so the memory used by a long running profiler stays bounded.
+	// nbFreed only counts the samples the reservoir saw, a lost sample would overstate the others
+	if (gc_dyn_array_size(profiler->freedSamples) < GC_PROFILER_MAX_FREED_SAMPLES) {
+		if (!gc_dyn_array_push(profiler->freedSamples, sample))
+			return -1;
+		++profiler->nbFreed;
+		return 0;
+	}
+
+	++profiler->nbFreed;
+	size_t pos = nextRandom(profiler) % profiler->nbFreed;
+	if (pos < GC_PROFILER_MAX_FREED_SAMPLES)
+		memcpy(gc_dyn_array_at(profiler->freedSamples, pos), sample, sizeof *sample);
+	return 0;
+}
+
+static int writeSample(gc_profiler_t const *profiler, FILE *file, gc_sample_t const *sample, double scale, bool onlyLive) {
+	assert(profiler != NULL && "The profiler must exist");
+	assert(file != NULL && "The file must exist");
+	assert(sample != NULL && "The sample must exist");
+
+	// folded stacks start with the root frame
+	if (sample->depth == 0)
+		fputs("[unknown]", file);
+	for (int i = sample->depth - 1; i >= 0; --i) {
+		writeFrame(file, sample->frames[i]);
+		if (i > 0)
+			fputc(';', file);
+	}
+
+	if (onlyLive)
+		fprintf(file, ";[survived %zu collections]", sample->survived);
+	return fprintf(file, " %.0f\n", estimatedBytes(profiler, sample) * scale) < 0 ? -1 : 0;
+}
+
+// interface
+
+gc_profiler_t* gc_profiler_create(size_t sampleRate) {
+	assert(sampleRate != 0 && "The sample rate can't be equal to 0");
+
+	gc_profiler_t *profiler = malloc(sizeof *profiler);
+	if (profiler) {
+		profiler->sampleRate = sampleRate;
+		profiler->rngState = ((uint64_t)time(NULL) << 1) | 1;
+		profiler->bytesUntilSample = nextSampleDistance(profiler);
+		profiler->nbFreed = 0;
+
+		profiler->liveSamples = gc_dyn_array_create(sizeof(gc_sample_t), 0, NULL);
+		profiler->freedSamples = gc_dyn_array_create(sizeof(gc_sample_t), 0, NULL);
+		if (!profiler->liveSamples || !profiler->freedSamples)
+			goto cleanup;
+		return profiler;
+	}
+	return NULL;
+cleanup:
+	if (profiler->liveSamples)
+		gc_dyn_array_release(profiler->liveSamples);
+	if (profiler->freedSamples)
+		gc_dyn_array_release(profiler->freedSamples);
+	free(profiler);
+	return NULL;
+}
+
+void gc_profiler_release(gc_profiler_t *profiler) {
+	assert(profiler != NULL && "The profiler must exist");
+
+	gc_dyn_array_release(profiler->liveSamples);
+	gc_dyn_array_release(profiler->freedSamples);
+	free(profiler);
+}
+
+bool gc_profiler_record(gc_profiler_t *profiler, void *data, size_t size) {
+	assert(profiler != NULL && "The profiler must exist");
+	assert(data != NULL && "The block of memory must exist");
+
+	// fast path: most allocations are not sampled
+	if (size < profiler->bytesUntilSample) {
+		profiler->bytesUntilSample -= size;
+		return false;
+	}
+	profiler->bytesUntilSample = nextSampleDistance(profiler);
+
+	gc_sample_t *sample = gc_dyn_array_push(profiler->liveSamples, NULL);
+	if (!sample)
+		return false;
+	sample->data = data;
+	sample->size = size;
+	sample->survived = 0;
+	sample->depth = 0;
+#ifdef GC_PROFILER_HAS_BACKTRACE
+	void *frames[GC_PROFILER_MAX_DEPTH + GC_PROFILER_SKIPPED_FRAMES];
+	int depth = backtrace(frames, GC_PROFILER_MAX_DEPTH + GC_PROFILER_SKIPPED_FRAMES) - GC_PROFILER_SKIPPED_FRAMES;
+	if (depth > 0) {
+		memcpy(sample->frames, frames + GC_PROFILER_SKIPPED_FRAMES, depth * sizeof(void*));
+		sample->depth = depth;
+	}
+#endif
+	return true;
+}
+
+void gc_profiler_free(gc_profiler_t *profiler, void *data) {
+	assert(profiler != NULL && "The profiler must exist");
+
+	for (size_t i = 0; i < gc_dyn_array_size(profiler->liveSamples); ++i) {
+		gc_sample_t *sample = gc_dyn_array_at(profiler->liveSamples, i);
+		if (sample->data != data)
+			continue;
+
+		// if the freed sample can't be kept, it must still leave the live samples
+		sample->data = NULL;
+		keepFreedSample(profiler, sample);
+
+		// the order of the samples doesn't matter, replace it by the last one
+		gc_sample_t *last = gc_dyn_array_back(profiler->liveSamples);
+		if (sample != last)
+			memcpy(sample, last, sizeof *sample);
+		gc_dyn_array_pop(profiler->liveSamples);
+		return;
+	}
+}
+
+void gc_profiler_collect(gc_profiler_t *profiler) {
+	assert(profiler != NULL && "The profiler must exist");
+
+	for (size_t i = 0; i < gc_dyn_array_size(profiler->liveSamples); ++i)
+		++((gc_sample_t*)gc_dyn_array_at(profiler->liveSamples, i))->survived;
+}
+
+int gc_profiler_write(gc_profiler_t *profiler, FILE *file, bool onlyLive) {
+	assert(profiler != NULL && "The profiler must exist");
+	assert(file != NULL && "The file must exist");
+
+	for (size_t i = 0; i < gc_dyn_array_size(profiler->liveSamples); ++i)
+		if (writeSample(profiler, file, gc_dyn_array_at(profiler->liveSamples, i), 1.0, onlyLive) == -1)
+			return -1;
+	if (onlyLive || gc_dyn_array_empty(profiler->freedSamples))
+		return 0;
+
+	// each kept freed sample stands for the ones the reservoir dropped
+	double scale = (double)profiler->nbFreed / (double)gc_dyn_array_size(profiler->freedSamples);
+	for (size_t i = 0; i < gc_dyn_array_size(profiler->freedSamples); ++i)
+		if (writeSample(profiler, file, gc_dyn_array_at(profiler->freedSamples, i), scale, onlyLive) == -1)
+			return -1;
+	return 0;
+}